@@ -1,6 +1,10 @@
 #include <vector>
 #include <iostream>
 #include <cassert>
+#include <memory>
+#include <random>
+#include <string>
+#include "../utils/bench.h"
 using namespace std;
 
 class BinaryIndexedTree {
@@ -148,7 +152,38 @@ public:
     }
 };
 
-int main() {
+// Benchmark, run with `bench [max_n]`.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    for (size_t n : bench::sizes(max_n)) {
+        vector<long> nums(n);
+        for (auto& x : nums) x = eng() % 1000;
+        vector<int> pos(1 << 20);
+        for (auto& p : pos) p = eng() % n;
+
+        unique_ptr<PointUpdateRangeQueryExectuor> purq;
+        bench::Record update("BinaryIndexedTree", "update", n);
+        bench::measure_build(update, [&] { purq.reset(new PointUpdateRangeQueryExectuor(nums)); });
+        bench::measure_ops(update, pos.size(), [&](size_t i) { purq->update(pos[i], 1); });
+        update.print();
+
+        long sink = 0;
+        bench::Record query("BinaryIndexedTree", "rangeSum", n);
+        bench::measure_ops(query, pos.size(), [&](size_t i) {
+            int l = pos[i], r = pos[i ^ 1];
+            sink += purq->rangeSum(min(l, r), max(l, r));
+        });
+        bench::do_not_optimize(sink);
+        query.print();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 1000000));
+        return 0;
+    }
+
     // point update range query
     PointUpdateRangeQueryExectuor purq(5);
     purq.update(0, 2);
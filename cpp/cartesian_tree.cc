@@ -5,6 +5,10 @@
 #include <iostream>
 #include <cassert>
 #include <random>
+#include <algorithm>
+#include <climits>
+#include <string>
+#include "../utils/bench.h"
 using namespace std;
 
 namespace cst_impl {
@@ -175,7 +179,34 @@ void random_test(string target_func, int default_value) {
     cout << "Test passed!" << endl;
 }
 
-int main() {
+// Benchmark, run with `bench [max_n]`.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    for (size_t n : bench::sizes(max_n)) {
+        vector<int> nums(n);
+        for (auto& x : nums) x = eng() % 1000000;
+        vector<size_t> pos(1 << 20);
+        for (auto& p : pos) p = eng() % n;
+
+        unique_ptr<CartesianTree<int>> ct;
+        bench::Record query("CartesianTree", "rangeQuery", n);
+        bench::measure_build(query, [&] { ct.reset(new CartesianTree<int>(nums)); });
+        long sink = 0;
+        bench::measure_ops(query, pos.size(), [&](size_t i) {
+            size_t l = pos[i], r = pos[i ^ 1];
+            sink += ct->rangeQuery(min(l, r), max(l, r));
+        });
+        bench::do_not_optimize(sink);
+        query.print();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 1000000));
+        return 0;
+    }
+
     random_test<std::less<int>>("min", INT_MAX);
     random_test<std::greater<int>>("max", INT_MIN);
 
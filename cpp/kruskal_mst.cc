@@ -2,34 +2,163 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <cstdint>
+#include <cassert>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cmath>
+#include "../utils/bench.h"
 using namespace std;
 
-int __get_root(vector<int>& root, int v) {
-    if (v == root[v]) return v;
-    return root[v] = __get_root(root, root[v]);
+// Disjoint set with union by size and iterative path halving, so that both the
+// tree height and the stack depth stay bounded on huge graphs.
+class DisjointSet {
+private:
+    vector<int> parent, size;
+
+public:
+    DisjointSet(int n) : parent(n), size(n, 1) { iota(parent.begin(), parent.end(), 0); }
+
+    int find(int v) {
+        while (v != parent[v]) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+
+    bool unite(int u, int v) {
+        u = find(u);
+        v = find(v);
+        if (u == v) return false;
+        if (size[u] < size[v]) swap(u, v);
+        parent[v] = u;
+        size[u] += size[v];
+        return true;
+    }
+
+    bool same(int u, int v) { return find(u) == find(v); }
+};
+
+// Edges kept as struct of arrays. Sorting works on packed 64-bit keys of
+// (weight, edge index), so the endpoints are never moved around.
+struct EdgeList {
+    vector<int> u, v, w;
+
+    EdgeList() = default;
+    EdgeList(const vector<pair<int, pair<int, int>>>& edges) {
+        reserve(edges.size());
+        for (auto& it : edges) add(it.second.first, it.second.second, it.first);
+    }
+
+    void reserve(size_t m) {
+        u.reserve(m);
+        v.reserve(m);
+        w.reserve(m);
+    }
+
+    void add(int a, int b, int c) {
+        u.push_back(a);
+        v.push_back(b);
+        w.push_back(c);
+    }
+
+    size_t size() const { return w.size(); }
+};
+
+namespace mst_impl {
+
+// ranges shorter than this are sorted directly instead of being partitioned
+constexpr ptrdiff_t FILTER_THRESHOLD = 1 << 12;
+
+// keys order by weight first, then by edge index, and are all distinct
+inline uint64_t make_key(int w, unsigned idx) {
+    return (uint64_t(uint32_t(w) ^ 0x80000000u) << 32) | idx;
+}
+
+inline unsigned key_index(uint64_t key) { return unsigned(key); }
+
+vector<uint64_t> make_keys(const EdgeList& edges) {
+    assert(edges.size() <= UINT32_MAX);
+    vector<uint64_t> keys(edges.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = make_key(edges.w[i], unsigned(i));
+    }
+    return keys;
 }
 
-bool __unite(vector<int>& root, int u, int v) {
-    u = __get_root(root, u);
-    v = __get_root(root, v);
-    if (u == v) return false;
-    root[v] = u;
-    return true;
+struct KruskalState {
+    const EdgeList& edges;
+    DisjointSet ds;
+    int components;
+    long weight = 0;
+    vector<unsigned>* chosen;
+
+    KruskalState(const EdgeList& edges, int n, vector<unsigned>* chosen)
+        : edges(edges), ds(n), components(n), chosen(chosen) {}
+
+    bool done() const { return components <= 1; }
+
+    // consume sorted keys in [first, last)
+    void scan(const uint64_t* first, const uint64_t* last) {
+        for (; first != last && !done(); ++first) {
+            unsigned i = key_index(*first);
+            if (ds.unite(edges.u[i], edges.v[i])) {
+                weight += edges.w[i];
+                --components;
+                if (chosen) chosen->push_back(i);
+            }
+        }
+    }
+};
+
+void filter_kruskal(uint64_t* first, uint64_t* last, KruskalState& st) {
+    if (last - first <= FILTER_THRESHOLD) {
+        sort(first, last);
+        st.scan(first, last);
+        return;
+    }
+
+    // median of three distinct keys, so both sides are non-empty
+    uint64_t a = first[0], b = first[(last - first) / 2], c = last[-1];
+    uint64_t pivot = max(min(a, b), min(max(a, b), c));
+    uint64_t* mid = partition(first, last, [pivot](uint64_t k) { return k < pivot; });
+
+    filter_kruskal(first, mid, st);
+    if (st.done()) return;
+
+    // drop heavy edges which already lie inside one component
+    last = remove_if(mid, last, [&st](uint64_t k) {
+        unsigned i = key_index(k);
+        return st.ds.same(st.edges.u[i], st.edges.v[i]);
+    });
+    filter_kruskal(mid, last, st);
 }
 
+}  // namespace mst_impl
+
 // Kruskal minimum spanning tree, vertexs start from 0
 // edge is in the form of (w, (u, v))
 long kruskal_mst(vector<pair<int, pair<int, int>>>& edges, int n) {
-    vector<int> root(n, 0), size(n, 1);
-    iota(root.begin(), root.end(), 0);
-
-    auto unite = [&](int u, int v) -> bool { return __unite(root, u, v); };
+    DisjointSet ds(n);
 
     long mst_weight = 0;
-    sort(edges.begin(), edges.end());
-    for (auto it : edges) {
+    sort(edges.begin(), edges.end(),
+         [](const pair<int, pair<int, int>>& a, const pair<int, pair<int, int>>& b) {
+             return a.first < b.first;
+         });
+    for (auto& it : edges) {
         int w = it.first, u = it.second.first, v = it.second.second;
-        if (unite(u, v)) {
+        if (ds.unite(u, v)) {
             mst_weight += w;
         }
     }
@@ -37,12 +166,609 @@ long kruskal_mst(vector<pair<int, pair<int, int>>>& edges, int n) {
     return mst_weight;
 }
 
-int main() {
+// Kruskal on the compact edge list, indices of the picked edges are appended
+// to chosen if given.
+long kruskal_mst(const EdgeList& edges, int n, vector<unsigned>* chosen = nullptr) {
+    vector<uint64_t> keys = mst_impl::make_keys(edges);
+    sort(keys.begin(), keys.end());
+
+    mst_impl::KruskalState st(edges, n, chosen);
+    st.scan(keys.data(), keys.data() + keys.size());
+    return st.weight;
+}
+
+// Filter-Kruskal: partition around a pivot weight, solve the light half first,
+// then discard heavy edges that no longer join two components before sorting them.
+long filter_kruskal_mst(const EdgeList& edges, int n, vector<unsigned>* chosen = nullptr) {
+    vector<uint64_t> keys = mst_impl::make_keys(edges);
+
+    mst_impl::KruskalState st(edges, n, chosen);
+    mst_impl::filter_kruskal(keys.data(), keys.data() + keys.size(), st);
+    return st.weight;
+}
+
+// Disjoint set safe for concurrent find and unite. Roots are linked by CAS,
+// the root with the larger index always goes below the smaller one.
+class ConcurrentDisjointSet {
+private:
+    vector<atomic<int>> parent;
+
+public:
+    ConcurrentDisjointSet(int n) : parent(n) {
+        for (int i = 0; i < n; ++i) parent[i].store(i, memory_order_relaxed);
+    }
+
+    int find(int v) {
+        while (true) {
+            int p = parent[v].load(memory_order_acquire);
+            if (p == v) return v;
+            int gp = parent[p].load(memory_order_acquire);
+            // path halving, losing the race here is harmless
+            if (p != gp) parent[v].compare_exchange_weak(p, gp, memory_order_acq_rel);
+            v = gp;
+        }
+    }
+
+    bool unite(int u, int v) {
+        while (true) {
+            u = find(u);
+            v = find(v);
+            if (u == v) return false;
+            if (u < v) swap(u, v);
+            int expected = u;
+            if (parent[u].compare_exchange_strong(expected, v, memory_order_acq_rel)) return true;
+        }
+    }
+};
+
+namespace mst_impl {
+
+// run f(tid, begin, end) on contiguous chunks of [0, n) in parallel
+template <class F>
+void parallel_for(int threads, size_t n, F f) {
+    vector<thread> pool;
+    size_t chunk = (n + threads - 1) / threads;
+    for (int t = 0; t < threads; ++t) {
+        size_t begin = min(n, t * chunk), end = min(n, begin + chunk);
+        if (t == threads - 1) {
+            f(t, begin, end);
+        } else {
+            pool.emplace_back(f, t, begin, end);
+        }
+    }
+    for (auto& th : pool) th.join();
+}
+
+inline void atomic_min(atomic<uint64_t>& a, uint64_t k) {
+    uint64_t cur = a.load(memory_order_relaxed);
+    while (k < cur && !a.compare_exchange_weak(cur, k, memory_order_relaxed)) {
+    }
+}
+
+}  // namespace mst_impl
+
+// Parallel Boruvka minimum spanning forest. Each round finds the lightest
+// outgoing edge of every component in parallel, contracts the components
+// through a concurrent disjoint set and compacts away edges that became
+// internal. Ties are broken by edge index, so the result matches kruskal_mst.
+long boruvka_mst(const EdgeList& edges, int n, vector<unsigned>* chosen = nullptr,
+                 int threads = 0) {
+    using namespace mst_impl;
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    assert(edges.size() <= UINT32_MAX);
+
+    ConcurrentDisjointSet ds(n);
+    vector<atomic<uint64_t>> best(n);
+    for (auto& b : best) b.store(UINT64_MAX, memory_order_relaxed);
+
+    vector<unsigned> active(edges.size()), next;
+    iota(active.begin(), active.end(), 0u);
+    vector<vector<unsigned>> keep(threads), picked(threads);
+    vector<long> weight(threads, 0);
+
+    while (!active.empty()) {
+        // lightest outgoing edge per component, internal edges are dropped
+        parallel_for(threads, active.size(), [&](int t, size_t begin, size_t end) {
+            keep[t].clear();
+            for (size_t j = begin; j < end; ++j) {
+                unsigned i = active[j];
+                int cu = ds.find(edges.u[i]), cv = ds.find(edges.v[i]);
+                if (cu == cv) continue;
+                keep[t].push_back(i);
+                uint64_t key = make_key(edges.w[i], i);
+                atomic_min(best[cu], key);
+                atomic_min(best[cv], key);
+            }
+        });
+
+        // contract, an edge picked by both of its components is only taken once
+        size_t before = 0;
+        for (auto& p : picked) before += p.size();
+        parallel_for(threads, n, [&](int t, size_t begin, size_t end) {
+            // sum locally, neighbouring slots of weight share a cache line
+            long sum = 0;
+            for (size_t v = begin; v < end; ++v) {
+                uint64_t key = best[v].load(memory_order_relaxed);
+                if (key == UINT64_MAX) continue;
+                best[v].store(UINT64_MAX, memory_order_relaxed);
+                unsigned i = key_index(key);
+                if (ds.unite(edges.u[i], edges.v[i])) {
+                    sum += edges.w[i];
+                    picked[t].push_back(i);
+                }
+            }
+            weight[t] += sum;
+        });
+        size_t after = 0;
+        for (auto& p : picked) after += p.size();
+        if (after == before) break;
+
+        // compact the surviving edges for the next round
+        vector<size_t> offset(threads + 1, 0);
+        for (int t = 0; t < threads; ++t) offset[t + 1] = offset[t] + keep[t].size();
+        next.resize(offset[threads]);
+        parallel_for(threads, threads, [&](int, size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                copy(keep[t].begin(), keep[t].end(), next.begin() + offset[t]);
+            }
+        });
+        active.swap(next);
+    }
+
+    long mst_weight = 0;
+    for (int t = 0; t < threads; ++t) {
+        mst_weight += weight[t];
+        if (chosen) chosen->insert(chosen->end(), picked[t].begin(), picked[t].end());
+    }
+    return mst_weight;
+}
+
+namespace mst_impl {
+
+// fixed-width record of a binary edge file
+struct EdgeRecord {
+    int32_t u, v, w;
+};
+static_assert(sizeof(EdgeRecord) == 12, "edge records must be packed");
+
+// records are handed out in blocks of this many to the consumers
+constexpr size_t BLOCK_RECORDS = 1 << 14;
+
+// Read-only mapping of a whole edge file.
+class MappedRun {
+private:
+    const EdgeRecord* data = nullptr;
+    size_t count = 0, bytes = 0;
+
+public:
+    MappedRun(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size % sizeof(EdgeRecord) != 0) {
+            close(fd);
+            throw runtime_error("bad edge file " + path);
+        }
+        bytes = st.st_size;
+        count = bytes / sizeof(EdgeRecord);
+        if (bytes != 0) {
+            void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("cannot map " + path);
+            }
+            madvise(p, bytes, MADV_SEQUENTIAL);
+            data = static_cast<const EdgeRecord*>(p);
+        }
+        close(fd);
+    }
+
+    MappedRun(const MappedRun&) = delete;
+    MappedRun& operator=(const MappedRun&) = delete;
+
+    ~MappedRun() {
+        if (data) munmap(const_cast<EdgeRecord*>(data), bytes);
+    }
+
+    size_t size() const { return count; }
+
+    template <class F>
+    void for_each_block(F f) const {
+        for (size_t i = 0; i < count; i += BLOCK_RECORDS) {
+            f(data + i, data + min(count, i + BLOCK_RECORDS));
+        }
+    }
+};
+
+// Bucket of records spilled into an anonymous temporary file.
+class FileRun {
+private:
+    FILE* file;
+    size_t count = 0;
+
+public:
+    FileRun() : file(tmpfile()) {
+        if (!file) throw runtime_error("cannot create temporary file");
+    }
+
+    FileRun(const FileRun&) = delete;
+    FileRun& operator=(const FileRun&) = delete;
+
+    ~FileRun() { fclose(file); }
+
+    void append(const EdgeRecord& e) {
+        if (fwrite(&e, sizeof(e), 1, file) != 1) throw runtime_error("write to bucket failed");
+        ++count;
+    }
+
+    size_t size() const { return count; }
+
+    template <class F>
+    void for_each_block(F f) const {
+        vector<EdgeRecord> block(min(count, BLOCK_RECORDS));
+        rewind(file);
+        for (size_t i = 0; i < count;) {
+            size_t got = fread(block.data(), sizeof(EdgeRecord), min(count - i, block.size()), file);
+            if (got == 0) throw runtime_error("read from bucket failed");
+            f(block.data(), block.data() + got);
+            i += got;
+        }
+    }
+};
+
+// Kruskal over runs that may not fit in memory. A run no larger than the
+// buffer is sorted in memory, bigger runs are split into weight buckets by
+// sampled quantiles and each bucket is solved in increasing weight order.
+class ExternalKruskal {
+private:
+    DisjointSet ds;
+    int components;
+    vector<EdgeRecord> buffer;
+    size_t buffer_records;
+    default_random_engine eng;
+
+    bool done() const { return components <= 1; }
+
+    void scan(const EdgeRecord* first, const EdgeRecord* last) {
+        for (; first != last && !done(); ++first) {
+            if (ds.unite(first->u, first->v)) {
+                weight += first->w;
+                --components;
+            }
+        }
+    }
+
+public:
+    long weight = 0;
+
+    ExternalKruskal(int n, size_t buffer_bytes)
+        : ds(n),
+          components(n),
+          buffer_records(max<size_t>(BLOCK_RECORDS, buffer_bytes / sizeof(EdgeRecord))),
+          eng(0) {}
+
+    template <class Run>
+    void solve(const Run& run) {
+        if (done() || run.size() == 0) return;
+
+        if (run.size() <= buffer_records) {
+            buffer.clear();
+            run.for_each_block([&](const EdgeRecord* first, const EdgeRecord* last) {
+                buffer.insert(buffer.end(), first, last);
+            });
+            sort(buffer.begin(), buffer.end(),
+                 [](const EdgeRecord& a, const EdgeRecord& b) { return a.w < b.w; });
+            scan(buffer.data(), buffer.data() + buffer.size());
+            return;
+        }
+
+        // pass 1: weight range and a reservoir sample of the weights
+        size_t buckets = min<size_t>(256, 2 * (run.size() / buffer_records + 1));
+        vector<int> sample;
+        sample.reserve(64 * buckets);
+        int lo = INT32_MAX, hi = INT32_MIN;
+        size_t seen = 0;
+        run.for_each_block([&](const EdgeRecord* first, const EdgeRecord* last) {
+            for (; first != last; ++first, ++seen) {
+                lo = min(lo, first->w);
+                hi = max(hi, first->w);
+                if (sample.size() < sample.capacity()) {
+                    sample.push_back(first->w);
+                } else {
+                    size_t j = uniform_int_distribution<size_t>(0, seen)(eng);
+                    if (j < sample.size()) sample[j] = first->w;
+                }
+            }
+        });
+
+        // all weights equal, any order is sorted
+        if (lo == hi) {
+            run.for_each_block([&](const EdgeRecord* first, const EdgeRecord* last) {
+                scan(first, last);
+            });
+            return;
+        }
+
+        // boundaries above the minimum, so every bucket is smaller than the run
+        sort(sample.begin(), sample.end());
+        vector<int> bounds;
+        for (size_t i = 1; i < buckets; ++i) {
+            int b = sample[i * sample.size() / buckets];
+            if (b > lo && (bounds.empty() || bounds.back() < b)) bounds.push_back(b);
+        }
+        if (bounds.empty()) bounds.push_back(hi);
+
+        // pass 2: spill into buckets
+        vector<unique_ptr<FileRun>> parts;
+        for (size_t i = 0; i <= bounds.size(); ++i) parts.emplace_back(new FileRun());
+        run.for_each_block([&](const EdgeRecord* first, const EdgeRecord* last) {
+            for (; first != last; ++first) {
+                size_t b = upper_bound(bounds.begin(), bounds.end(), first->w) - bounds.begin();
+                parts[b]->append(*first);
+            }
+        });
+
+        for (auto& part : parts) {
+            solve(*part);
+            part.reset();
+        }
+    }
+};
+
+}  // namespace mst_impl
+
+// Minimum spanning forest of a binary edge file of packed int32 (u, v, w)
+// records. The file is mapped rather than loaded, and peak memory stays at
+// O(n + buffer_bytes).
+long external_kruskal_mst(const string& path, int n, size_t buffer_bytes = size_t(64) << 20) {
+    mst_impl::MappedRun input(path);
+    mst_impl::ExternalKruskal solver(n, buffer_bytes);
+    solver.solve(input);
+    return solver.weight;
+}
+
+// Write m random edges over n vertexs in the format read by external_kruskal_mst.
+void write_random_edge_file(const string& path, int n, long m, unsigned seed = 0) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) throw runtime_error("cannot create " + path);
+
+    default_random_engine eng(seed);
+    uniform_int_distribution<int> vertex_dist(0, n - 1), weight_dist(0, 1 << 20);
+    vector<mst_impl::EdgeRecord> block(mst_impl::BLOCK_RECORDS);
+    for (long i = 0; i < m;) {
+        size_t len = min<long>(m - i, block.size());
+        for (size_t j = 0; j < len; ++j) {
+            block[j] = {vertex_dist(eng), vertex_dist(eng), weight_dist(eng)};
+        }
+        if (fwrite(block.data(), sizeof(block[0]), len, file) != len) {
+            fclose(file);
+            throw runtime_error("write to " + path + " failed");
+        }
+        i += len;
+    }
+    fclose(file);
+}
+
+// Minimum spanning forest maintained under batches of edge insertions. Only
+// the current forest is kept, because an edge left out of the forest stays
+// out after more edges are inserted. Each batch is merged by running Kruskal
+// on the forest plus the batch, which costs O((n + b) log(n + b)).
+class IncrementalMST {
+private:
+    int n;
+    long weight = 0;
+    EdgeList forest;
+
+public:
+    IncrementalMST(int n) : n(n) {}
+
+    long add_batch(const EdgeList& batch) {
+        EdgeList merged = forest;
+        merged.reserve(forest.size() + batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) merged.add(batch.u[i], batch.v[i], batch.w[i]);
+
+        vector<unsigned> chosen;
+        chosen.reserve(n);
+        weight = kruskal_mst(merged, n, &chosen);
+
+        EdgeList next;
+        next.reserve(chosen.size());
+        for (auto i : chosen) next.add(merged.u[i], merged.v[i], merged.w[i]);
+        forest = std::move(next);
+        return weight;
+    }
+
+    long add_edge(int u, int v, int w) {
+        EdgeList batch;
+        batch.add(u, v, w);
+        return add_batch(batch);
+    }
+
+    long mst_weight() const { return weight; }
+
+    const EdgeList& edges() const { return forest; }
+};
+
+void random_test() {
+    int n = 2000, m = 20000;
+
+    random_device r;
+    default_random_engine eng(r());
+    uniform_int_distribution<int> vertex_dist(0, n - 1), weight_dist(-1000, 1000);
+
+    vector<pair<int, pair<int, int>>> edges;
+    for (int i = 0; i < m; ++i) {
+        edges.push_back({weight_dist(eng), {vertex_dist(eng), vertex_dist(eng)}});
+    }
+    EdgeList list(edges);
+
+    cout << "Begin random test on " << n << " vertexs and " << m << " edges!" << endl;
+    long expected = kruskal_mst(edges, n);
+    vector<unsigned> chosen;
+    long sorted = kruskal_mst(list, n);
+    long filtered = filter_kruskal_mst(list, n, &chosen);
+    assert(sorted == expected);
+    assert(filtered == expected);
+    (void)sorted;
+    (void)filtered;
+
+    long sum = 0;
+    for (auto i : chosen) sum += list.w[i];
+    assert(sum == expected);
+
+    for (int threads : {1, 2, 4}) {
+        chosen.clear();
+        long got = boruvka_mst(list, n, &chosen, threads);
+        assert(got == expected);
+        (void)got;
+        sum = 0;
+        for (auto i : chosen) sum += list.w[i];
+        assert(sum == expected);
+    }
+    cout << " + mst weight\t= " << expected << endl;
+    cout << "Test passed!" << endl;
+}
+
+void incremental_test() {
+    int n = 1000, batches = 20, batch_size = 500;
+
+    random_device r;
+    default_random_engine eng(r());
+    uniform_int_distribution<int> vertex_dist(0, n - 1), weight_dist(-1000, 1000);
+
+    cout << "Begin incremental test on " << batches << " batches!" << endl;
+    IncrementalMST mst(n);
+    EdgeList all;
+    for (int k = 0; k < batches; ++k) {
+        EdgeList batch;
+        for (int i = 0; i < batch_size; ++i) {
+            batch.add(vertex_dist(eng), vertex_dist(eng), weight_dist(eng));
+            all.add(batch.u.back(), batch.v.back(), batch.w.back());
+        }
+        long expected = kruskal_mst(all, n);
+        long got = mst.add_batch(batch);
+        assert(got == expected);
+        (void)got;
+        (void)expected;
+        assert(int(mst.edges().size()) < n);
+    }
+    cout << " + mst weight\t= " << mst.mst_weight() << endl;
+    cout << "Test passed!" << endl;
+}
+
+void external_test() {
+    int n = 20000;
+    long m = 200000;
+    string path = "kruskal_mst_edges.bin";
+    write_random_edge_file(path, n, m, random_device()());
+
+    EdgeList list;
+    mst_impl::MappedRun run(path);
+    run.for_each_block([&](const mst_impl::EdgeRecord* first, const mst_impl::EdgeRecord* last) {
+        for (; first != last; ++first) list.add(first->u, first->v, first->w);
+    });
+
+    cout << "Begin external test on " << n << " vertexs and " << m << " edges!" << endl;
+    long expected = kruskal_mst(list, n);
+    // a tiny buffer forces bucket partitioning
+    long partitioned = external_kruskal_mst(path, n, 1 << 10);
+    long buffered = external_kruskal_mst(path, n);
+    assert(partitioned == expected);
+    assert(buffered == expected);
+    (void)partitioned;
+    (void)buffered;
+    remove(path.c_str());
+    cout << " + mst weight\t= " << expected << endl;
+    cout << "Test passed!" << endl;
+}
+
+EdgeList random_graph(int n, long m, default_random_engine& eng) {
+    uniform_int_distribution<int> vertex_dist(0, n - 1), weight_dist(0, 1 << 20);
+    EdgeList list;
+    list.reserve(m);
+    for (long i = 0; i < m; ++i) list.add(vertex_dist(eng), vertex_dist(eng), weight_dist(eng));
+    return list;
+}
+
+EdgeList grid_graph(int side, default_random_engine& eng) {
+    uniform_int_distribution<int> weight_dist(0, 1 << 20);
+    EdgeList list;
+    list.reserve(2L * side * side);
+    for (int i = 0; i < side; ++i) {
+        for (int j = 0; j < side; ++j) {
+            int v = i * side + j;
+            if (j + 1 < side) list.add(v, v + 1, weight_dist(eng));
+            if (i + 1 < side) list.add(v, v + side, weight_dist(eng));
+        }
+    }
+    return list;
+}
+
+void bench_graph(const string& graph, const EdgeList& list, int n) {
+    long expected = 0, got = 0;
+    auto record = [&](const string& op) {
+        bench::Record rec("kruskal_mst", op, n);
+        rec.set("graph", graph).set("edges", list.size());
+        return rec;
+    };
+
+    bench::Record kruskal = record("kruskal");
+    bench::measure_ops(kruskal, 1, [&](size_t) { expected = kruskal_mst(list, n); });
+    kruskal.print();
+
+    bench::Record filter = record("filter_kruskal");
+    bench::measure_ops(filter, 1, [&](size_t) { got = filter_kruskal_mst(list, n); });
+    assert(got == expected);
+    filter.print();
+
+    int max_threads = max(1u, thread::hardware_concurrency());
+    for (int threads = 1;; threads = min(threads * 2, max_threads)) {
+        bench::Record boruvka = record("boruvka");
+        boruvka.set("threads", threads);
+        bench::measure_ops(boruvka, 1,
+                           [&](size_t) { got = boruvka_mst(list, n, nullptr, threads); });
+        assert(got == expected);
+        boruvka.print();
+        if (threads == max_threads) break;
+    }
+}
+
+// Benchmark, run with `bench [max_n]`. Random graphs have 8 edges per vertex,
+// grid graphs are square.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    for (size_t n : bench::sizes(max_n)) {
+        bench_graph("random", random_graph(n, 8L * n, eng), n);
+        int side = sqrt(double(n));
+        bench_graph("grid", grid_graph(side, eng), side * side);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 1000000));
+        return 0;
+    }
+    if (argc > 4 && string(argv[1]) == "gen") {
+        write_random_edge_file(argv[2], stoi(argv[3]), stol(argv[4]));
+        return 0;
+    }
+    if (argc > 3 && string(argv[1]) == "external") {
+        cout << external_kruskal_mst(argv[2], stoi(argv[3])) << endl;
+        return 0;
+    }
+
     int n = 4;
     vector<pair<int, pair<int, int>>> edges = {
         {1, {0, 1}}, {3, {0, 2}}, {7, {0, 3}}, {2, {1, 2}}, {3, {1, 3}}, {3, {2, 3}},
     };
 
-    cout << kruskal_mst(edges, n) << endl;
+    EdgeList list(edges);
+    cout << kruskal_mst(edges, n) << endl;         // 6
+    cout << filter_kruskal_mst(list, n) << endl;  // 6
+
+    random_test();
+    incremental_test();
+    external_test();
     return 0;
 }
@@ -1,5 +1,11 @@
 #include <algorithm>
 #include <vector>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <memory>
+#include "../utils/bench.h"
 using namespace std;
 
 // Segment tree supports range maximum query, with range update and lazy propagation.
@@ -63,3 +69,48 @@ public:
 
     int get(int l, int r) { return get(0, 0, n, l, r); }
 };
+
+// Benchmark, run with `bench [max_n]`.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    for (size_t n : bench::sizes(max_n)) {
+        vector<int> pos(1 << 20);
+        for (auto& p : pos) p = eng() % n;
+
+        unique_ptr<SegmentTree> st;
+        bench::Record update("SegmentTree", "add", n);
+        bench::measure_build(update, [&] { st.reset(new SegmentTree(n)); });
+        bench::measure_ops(update, pos.size(), [&](size_t i) {
+            int l = pos[i], r = pos[i ^ 1];
+            st->add(min(l, r), max(l, r) + 1, 1);
+        });
+        update.print();
+
+        long sink = 0;
+        bench::Record query("SegmentTree", "get", n);
+        bench::measure_ops(query, pos.size(), [&](size_t i) {
+            int l = pos[i], r = pos[i ^ 1];
+            sink += st->get(min(l, r), max(l, r) + 1);
+        });
+        bench::do_not_optimize(sink);
+        query.print();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 1000000));
+        return 0;
+    }
+
+    // ranges are half open, [l, r)
+    SegmentTree st(5);
+    st.add(0, 3, 2);
+    st.add(2, 5, 1);
+    cout << st.get(0, 5) << endl;  // 3
+    cout << st.get(0, 2) << endl;  // 2
+    cout << st.get(3, 5) << endl;  // 1
+    assert(st.get(0, 5) == 3 && st.get(0, 2) == 2 && st.get(3, 5) == 1);
+
+    return 0;
+}
@@ -5,6 +5,13 @@
 #include <limits>
 #include <type_traits>
 #include <random>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include "../utils/bits.h"
+#include "../utils/bench.h"
+// the old shift cascade, only kept as the benchmark baseline
+#include "../utils/fls.c"
 using namespace std;
 
 namespace st_impl {
@@ -16,7 +23,7 @@ public:
     typedef unsigned size_type;
     typedef T value_type;
 
-    SparseTable(const vector<T>& init) : _size(init.size()), _idx_size(flsl(_size)) {
+    SparseTable(const vector<T>& init) : _size(init.size()), _idx_size(bits::fls(_size)) {
         table.resize(_size);
         for (auto& row : table) {
             row.resize(_idx_size, func_type::default_value);
@@ -50,7 +57,7 @@ public:
         // then rangeQuery will be executed in O(1).
         // otherwise it should be finished in O(lgN).
         if (func_type::idempotent) {
-            size_type idx = flsl(r - l + 1) - 1;
+            size_type idx = bits::floor_log2(r - l + 1);
             return f(table[l][idx], table[r - (1 << idx) + 1][idx]);
         } else {
             T res = func_type::default_value;
@@ -65,6 +72,34 @@ public:
         }
     }
 
+    // Answer the queries [l[i], r[i]] of a batch. For idempotent functions the
+    // levels of all queries are computed in one vectorized pass first.
+    vector<T> rangeQuery(const vector<size_type>& l, const vector<size_type>& r) const {
+        if (l.size() != r.size()) {
+            throw std::invalid_argument("Bad batch!");
+        }
+        size_t n = l.size();
+        vector<T> res(n);
+        if (!func_type::idempotent) {
+            for (size_t i = 0; i < n; ++i) res[i] = rangeQuery(l[i], r[i]);
+            return res;
+        }
+
+        vector<uint32_t> len(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (!(l[i] <= r[i] && r[i] < _size)) {
+                throw std::out_of_range("Bad query!");
+            }
+            len[i] = r[i] - l[i] + 1;
+        }
+        vector<int32_t> idx(n);
+        bits::floor_log2_batch(len.data(), idx.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            res[i] = f(table[l[i]][idx[i]], table[r[i] - (1 << idx[i]) + 1][idx[i]]);
+        }
+        return res;
+    }
+
 private:
     func_type f;
 
@@ -181,9 +216,90 @@ void regular_test() {
     assert(st_sum.rangeQuery(3, 6) == 25);
     assert(st_sum.rangeQuery(0, 6) == 31);
     assert(st_sum.rangeQuery(2, 4) == 9);
+
+    vector<unsigned> ls = {0, 3, 0, 2}, rs = {2, 6, 6, 4};
+    assert((st_max.rangeQuery(ls, rs) == vector<int>{3, 10, 10, 5}));
+    assert((st_sum.rangeQuery(ls, rs) == vector<int>{6, 25, 31, 9}));
+
+    // batch kernel against the scalar one on every bit length
+    vector<uint32_t> len;
+    for (int b = 0; b < 32; ++b) {
+        len.push_back(1u << b);
+        len.push_back((1u << b) | ((1u << b) - 1));
+        len.push_back((1u << b) + 1);
+    }
+    len.push_back(0);
+    vector<int32_t> idx(len.size());
+    bits::floor_log2_batch(len.data(), idx.data(), len.size());
+    for (size_t i = 0; i < len.size(); ++i) {
+        assert(idx[i] == bits::floor_log2(len[i]) && idx[i] == flsl(len[i]) - 1);
+    }
+}
+
+// Benchmark, run with `bench [max_n]`.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    for (size_t n : bench::sizes(max_n)) {
+        vector<int> nums(n);
+        for (auto& x : nums) x = eng() % 1000000;
+        vector<unsigned> pos(1 << 20);
+        for (auto& p : pos) p = eng() % n;
+
+        unique_ptr<SparseTable<int>> st;
+        bench::Record query("SparseTable", "rangeQuery", n);
+        bench::measure_build(query, [&] { st.reset(new SparseTable<int>(nums)); });
+        long sink = 0;
+        bench::measure_ops(query, pos.size(), [&](size_t i) {
+            unsigned l = pos[i], r = pos[i ^ 1];
+            sink += st->rangeQuery(min(l, r), max(l, r));
+        });
+        query.print();
+
+        vector<unsigned> ls(pos.size()), rs(pos.size());
+        for (size_t i = 0; i < pos.size(); ++i) {
+            ls[i] = min(pos[i], pos[i ^ 1]);
+            rs[i] = max(pos[i], pos[i ^ 1]);
+        }
+        bench::Record batch("SparseTable", "rangeQuery_batch", n);
+        double ops_per_s = bench::measure_ops(batch, 3, [&](size_t) {
+            for (int x : st->rangeQuery(ls, rs)) sink += x;
+        });
+        batch.set("queries_per_s", ops_per_s * pos.size());
+        bench::do_not_optimize(sink);
+        batch.print();
+    }
+
+    // floor log2 kernels over random lengths of every magnitude
+    vector<uint32_t> len(1 << 20);
+    for (auto& x : len) x = uint32_t(eng()) >> (eng() % 32) | 1;
+    vector<int32_t> out(len.size());
+    long sink = 0;
+    // one op is a pass over the whole array, so every variant is timed alike
+    auto kernel = [&](const string& op, auto f) {
+        bench::Record rec("bits", op, len.size());
+        double ops_per_s = bench::measure_ops(rec, 3, [&](size_t) {
+            f();
+            sink += out[0];
+        });
+        rec.set("values_per_s", ops_per_s * len.size());
+        rec.print();
+    };
+    kernel("flsl_cascade", [&] {
+        for (size_t i = 0; i < len.size(); ++i) out[i] = flsl(len[i]) - 1;
+    });
+    kernel("fls_builtin", [&] {
+        for (size_t i = 0; i < len.size(); ++i) out[i] = bits::floor_log2(len[i]);
+    });
+    kernel("floor_log2_batch", [&] { bits::floor_log2_batch(len.data(), out.data(), len.size()); });
+    bench::do_not_optimize(sink);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 1000000));
+        return 0;
+    }
+
     regular_test();
 
     random_test<max_f<int>>("max");
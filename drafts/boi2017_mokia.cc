@@ -20,6 +20,13 @@
 #include <utility>
 #include <iomanip>
 #include <cassert>
+#include <random>
+
+#include <fcntl.h>
+
+#include "../utils/bench.h"
+#include "../utils/cdq.h"
+#include "../utils/fast_io.h"
 
 using namespace std;
 
@@ -59,93 +66,215 @@ void __args_output(vector<string>::iterator it, vector<string>::iterator end, T
 #define out(args...) { vector<string> __args = __macro_split(#args); __args_output(__args.begin(), __args.end(), args); }
 // clang-format on
 
-const int MAX_N = 200000;
+// One event of the offline solution. An update adds value at (x, y1), a
+// rectangle query is split into two prefix queries over x, at x1 - 1 with
+// sign value = -1 and at x2 with sign value = 1, both asking for [y1, y2].
+struct Event {
+    int x, y1, y2, value, id;
+    long result;
 
-struct Command {
-    int op, id, x1, y1, x2, y2;
+    bool is_update() const { return id < 0; }
+    bool is_query() const { return id >= 0; }
+};
 
-    bool operator<(const Command& other) const {
-        if (x1 == other.x1) return op < other.op;
-        return x1 < other.x1;
-    }
+struct EventX {
+    int operator()(const Event& e) const { return e.x; }
 };
 
-int n;
-int bit[MAX_N * 10];
+// Binary indexed tree over y, the inner structure of the cdq.
+class RangeBit {
+private:
+    vector<long> bit;
 
-void add(int i, int delta) {
-    while (i <= n) {
-        bit[i] += delta;
-        i += (i & -i);
+    void add(int i, long delta) {
+        while (i < sz(bit)) {
+            bit[i] += delta;
+            i += (i & -i);
+        }
     }
-}
 
-int sum(int i) {
-    int ans = 0;
-    while (i > 0) {
-        ans += bit[i];
-        i -= (i & -i);
+    long sum(int i) const {
+        long ans = 0;
+        while (i > 0) {
+            ans += bit[i];
+            i -= (i & -i);
+        }
+        return ans;
+    }
+
+public:
+    RangeBit(int n) : bit(n + 1) {}
+
+    void insert(const Event& e) { add(e.y1, e.value); }
+    void erase(const Event& e) { add(e.y1, -e.value); }
+    void answer(Event& e) { e.result += e.value * (sum(e.y2) - sum(e.y1 - 1)); }
+};
+
+// Answers of the queries in input order. y is compressed to the distinct
+// update rows first, so every worker's RangeBit stays O(updates) and not
+// O(grid size).
+vector<long> solve(vector<Event>& events, int cnt_q, int threads = 0) {
+    vector<int> ys;
+    for (auto& e : events) {
+        if (e.is_update()) ys.pb(e.y1);
+    }
+    sort(all(ys));
+    ys.erase(unique(all(ys)), ys.end());
+    // a query keeps the compressed rows inside [y1, y2], possibly none
+    for (auto& e : events) {
+        if (e.is_query()) e.y2 = upper_bound(all(ys), e.y2) - ys.begin();
+        e.y1 = lower_bound(all(ys), e.y1) - ys.begin() + 1;
+    }
+
+    Cdq<Event, EventX, RangeBit>(EventX(), RangeBit(sz(ys)), threads).run(events);
+
+    vector<long> ans(cnt_q);
+    for (auto& e : events) {
+        if (e.is_query()) ans[e.id] += e.result;
     }
     return ans;
 }
 
-int range_sum(int i, int j) {
-    return sum(j) - sum(i - 1);
+void add_query(vector<Event>& events, int id, int x1, int y1, int x2, int y2) {
+    events.pb(Event{x1 - 1, y1, y2, -1, id, 0});
+    events.pb(Event{x2, y1, y2, 1, id, 0});
 }
 
-Command com[MAX_N], com_t[MAX_N];
-int ans[MAX_N];
-
-void cdq(int l, int r) {
-    if (l >= r) return;
-    int m = (l + r) / 2;
-    cdq(l, m);
-    cdq(m + 1, r);
-
-    int cnt = 0;
-    reps(i, 0, m) { com_t[cnt++] = com[i]; }
-    reps(i, m + 1, r) {
-        if (com[i].op == 2) {
-            com_t[cnt] = com[i];
-            com_t[cnt++].op = 0;
-            com_t[cnt] = com[i];
-            com_t[cnt++].x1 = com[i].x2;
+// Compare against brute force on random commands, run with `test`.
+void random_test() {
+    mt19937 eng(random_device{}());
+    int n = 50;
+    vector<Event> events;
+    vector<long> expected;
+    vector<vector<long>> grid(n + 1, vector<long>(n + 1));
+
+    rep(t, 20000) {
+        int x1 = eng() % n + 1, y1 = eng() % n + 1;
+        if (eng() % 2) {
+            int a = eng() % 100;
+            events.pb(Event{x1, y1, 0, a, -1, 0});
+            grid[x1][y1] += a;
+        } else {
+            int x2 = x1 + eng() % (n - x1 + 1), y2 = y1 + eng() % (n - y1 + 1);
+            add_query(events, sz(expected), x1, y1, x2, y2);
+            long res = 0;
+            repse(x, x1, x2) repse(y, y1, y2) res += grid[x][y];
+            expected.pb(res);
         }
     }
 
-    sort(com_t, com_t + cnt);
+    for (int threads : {1, 4}) {
+        vector<Event> copy = events;
+        vector<long> got = solve(copy, sz(expected), threads);
+        assert(got == expected);
+    }
+    cout << "Test passed!" << endl;
+}
+
+// Write and parse back integers of every length through a file.
+void io_test() {
+    mt19937_64 eng(random_device{}());
+    vector<long> nums = {0, -1, 9, 10, 99999999, 100000000, -123456789012345678, LONG_MAX};
+    rep(i, 10000) nums.pb(long(eng() >> (eng() % 64)) * (i % 2 ? 1 : -1));
 
-    rep(i, cnt) {
-        if (com_t[i].op == 0) {
-            ans[com_t[i].id] -= range_sum(com_t[i].y1, com_t[i].y2);
-        } else if (com_t[i].op == 1) {
-            add(com_t[i].y1, com_t[i].x2);
-        } else {
-            ans[com_t[i].id] += range_sum(com_t[i].y1, com_t[i].y2);
+    string path = "boi2017_mokia_io.txt";
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    {
+        FastOutput output(fd);
+        for (long x : nums) output.write(x).put(x % 3 ? ' ' : '\n');
+    }
+    close(fd);
+
+    fd = open(path.c_str(), O_RDONLY);
+    FastInput input(fd);
+    vector<long> parsed;
+    long x;
+    while (input.read(x)) parsed.pb(x);
+    assert(parsed == nums);
+    close(fd);
+    remove(path.c_str());
+    cout << "Test passed!" << endl;
+}
+
+// Parse throughput on a generated command file of max_n bytes, against scanf.
+void benchmark(size_t max_n) {
+    string path = "boi2017_mokia_bench.txt";
+    mt19937 eng(42);
+    int w = 2000000;
+    {
+        int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+        FastOutput output(fd);
+        output.write("0 ").write(w).put('\n');
+        while (output.size() < max_n) {
+            int x = eng() % w + 1, y = eng() % w + 1;
+            if (eng() % 2) {
+                output.write("1 ").write(x).put(' ').write(y).put(' ').write(eng() % 100).put('\n');
+            } else {
+                output.write("2 ").write(x).put(' ').write(y).put(' ');
+                output.write(x + eng() % (w - x + 1)).put(' ').write(y + eng() % (w - y + 1)).put('\n');
+            }
         }
+        output.write("3\n");
+        output.flush();
+        close(fd);
     }
+
+    long sink = 0;
+    size_t bytes = 0;
+    bench::Record fast("FastInput", "parse", max_n);
+    double ops_per_s = bench::measure_ops(fast, 1, [&](size_t) {
+        int fd = open(path.c_str(), O_RDONLY);
+        FastInput input(fd);
+        bytes = input.bytes();
+        long x;
+        while (input.read(x)) sink += x;
+        close(fd);
+    });
+    fast.set("bytes", bytes).set("bytes_per_s", ops_per_s * bytes);
+    fast.print();
+
+    bench::Record slow("FastInput", "scanf", max_n);
+    ops_per_s = bench::measure_ops(slow, 1, [&](size_t) {
+        FILE* f = fopen(path.c_str(), "r");
+        long x;
+        while (fscanf(f, "%ld", &x) == 1) sink += x;
+        fclose(f);
+    });
+    slow.set("bytes", bytes).set("bytes_per_s", ops_per_s * bytes);
+    slow.print();
+    bench::do_not_optimize(sink);
+    remove(path.c_str());
 }
 
-int main() {
-    int op, a, b, c, d;
-    scanf("%d %d", &op, &n);
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "test") {
+        random_test();
+        io_test();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 100000000));
+        return 0;
+    }
 
-    int cnt = 0, cnt_q = 0;
-    while (op != 3) {
-        scanf("%d", &op);
+    FastInput input;
+    int op = input.next<int>();
+    input.next<int>();  // grid size, not needed once y is compressed
+
+    vector<Event> events;
+    int cnt_q = 0;
+    while (op != 3 && input.read(op)) {
         if (op == 1) {
-            scanf("%d %d %d", &a, &b, &c);
-            com[cnt++] = Command{op, -1, a, b, c, 0};
+            int a = input.next<int>(), b = input.next<int>(), c = input.next<int>();
+            events.pb(Event{a, b, 0, c, -1, 0});
         } else if (op == 2) {
-            scanf("%d %d %d %d", &a, &b, &c, &d);
-            com[cnt++] = Command{op, cnt_q++, a, b, c, d};
+            int a = input.next<int>(), b = input.next<int>(), c = input.next<int>(), d = input.next<int>();
+            add_query(events, cnt_q++, a, b, c, d);
         }
     }
 
-    cdq(1, cnt);
-
-    rep(i, cnt) { printf("%d ", ans[i]); }
-    printf("\n");
+    FastOutput output;
+    for (long x : solve(events, cnt_q)) output.write(x).put('\n');
 
     return 0;
 }
@@ -1,5 +1,26 @@
 #include <string>
+#include <string_view>
 #include <vector>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <memory>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../utils/bench.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KMP_SIMD_X86
+#endif
 using namespace std;
 
 vector<int> make_next(const string &str) {
@@ -31,3 +52,654 @@ int kmp(const string &str, const string &pattern) {
     }
     return res;
 }
+
+// Streaming KMP: the text arrives as successive chunks, e.g. read() buffers
+// or slices of a mapped file, and the partial match q is carried across chunk
+// boundaries. Offsets are absolute positions in the whole stream, and memory
+// does not depend on the length of the text. Copies share the next table and
+// carry their own match state.
+class KmpMatcher {
+public:
+    KmpMatcher(const string &pattern)
+        : pattern(pattern), next(make_shared<const vector<int>>(make_next(pattern))) {
+        assert(!pattern.empty());
+    }
+
+    // Call on_match(offset) for every match ending inside chunk.
+    template <class F>
+    void feed(string_view chunk, F on_match) {
+        // keep the state in locals, so the callback cannot force reloads
+        int m = pattern.size(), k = q;
+        const char *p = pattern.data();
+        const int *nx = next->data();
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            while (k > 0 && p[k] != chunk[i]) {
+                k = nx[k - 1];
+            }
+            if (p[k] == chunk[i]) ++k;
+            if (k == m) {
+                on_match(consumed + i + 1 - m);
+                k = nx[k - 1];
+            }
+        }
+        q = k;
+        consumed += chunk.size();
+    }
+
+    // start over on a new stream, whose first byte is at offset
+    void reset(size_t offset = 0) {
+        q = 0;
+        consumed = offset;
+    }
+
+    size_t position() const { return consumed; }
+
+private:
+    string pattern;
+    shared_ptr<const vector<int>> next;
+    int q = 0;
+    size_t consumed = 0;
+};
+
+// Stream the file at path through KMP in fixed-size blocks, returns the number
+// of matches and passes each match offset to on_match.
+template <class F>
+size_t kmp_file(const string &path, const string &pattern, F on_match,
+                size_t block_size = size_t(1) << 20) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("cannot open " + path);
+
+    KmpMatcher matcher(pattern);
+    vector<char> block(block_size);
+    size_t res = 0;
+    while (true) {
+        ssize_t got = read(fd, block.data(), block.size());
+        if (got < 0) {
+            close(fd);
+            throw runtime_error("read from " + path + " failed");
+        }
+        if (got == 0) break;
+        matcher.feed(string_view(block.data(), got), [&](size_t offset) {
+            ++res;
+            on_match(offset);
+        });
+    }
+    close(fd);
+    return res;
+}
+
+// Parallel KMP. Thread t owns the match starts in its chunk [begin, end) and
+// scans up to end + m - 1, so the chunks overlap by m - 1 bytes and each match
+// is found by exactly one thread. All threads share one next table.
+class ParallelKmp {
+public:
+    ParallelKmp(const string &pattern, int threads = 0) : matcher(pattern), m(pattern.size()) {
+        this->threads = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+    }
+
+    // Each thread collects into locals and stores into res once, neighbouring
+    // slots of res share a cache line.
+    size_t count(const string &str) const {
+        vector<size_t> res(threads, 0);
+        run(str, [&res](int t, KmpMatcher &local, string_view chunk) {
+            size_t cnt = 0;
+            local.feed(chunk, [&cnt](size_t) { ++cnt; });
+            res[t] = cnt;
+        });
+        return accumulate(res.begin(), res.end(), size_t(0));
+    }
+
+    // sorted offsets of all matches
+    vector<size_t> offsets(const string &str) const {
+        vector<vector<size_t>> res(threads);
+        run(str, [&res](int t, KmpMatcher &local, string_view chunk) {
+            vector<size_t> found;
+            local.feed(chunk, [&found](size_t offset) { found.push_back(offset); });
+            res[t] = std::move(found);
+        });
+        // chunks are in text order, so concatenating keeps the offsets sorted
+        vector<size_t> all;
+        for (auto &r : res) all.insert(all.end(), r.begin(), r.end());
+        return all;
+    }
+
+private:
+    // chunks smaller than this are not worth a thread
+    static constexpr size_t MIN_CHUNK = 1 << 16;
+
+    KmpMatcher matcher;
+    size_t m;
+    int threads;
+
+    // scan(t, matcher, chunk) runs on thread t with a matcher positioned at
+    // the start of its chunk
+    template <class F>
+    void run(const string &str, F scan) const {
+        size_t n = str.size();
+        int used = max<size_t>(1, min<size_t>(threads, n / MIN_CHUNK));
+        size_t chunk = (n + used - 1) / used;
+
+        vector<thread> pool;
+        auto work = [&](int t) {
+            size_t begin = min(n, t * chunk), end = min(n, begin + chunk + m - 1);
+            KmpMatcher local = matcher;
+            local.reset(begin);
+            scan(t, local, string_view(str).substr(begin, end - begin));
+        };
+        for (int t = 1; t < used; ++t) pool.emplace_back(work, t);
+        work(0);
+        for (auto &th : pool) th.join();
+    }
+};
+
+namespace kmp_impl {
+
+// Prefilter kernels. Each one tests the first and last byte of the pattern
+// against a block of text positions at once and only verifies the
+// candidates. It counts the matches starting in [0, *resume) and stops early
+// once the bytes spent on verification outgrow the bytes scanned, so the
+// caller can finish with KMP and keep the O(n + m) bound on repetitive inputs.
+typedef size_t (*prefilter_fn)(const char *, size_t, const char *, size_t, size_t *);
+
+// Compare a and b, return the bytes looked at: len on a match, otherwise the
+// length of the common prefix plus the mismatching byte.
+inline size_t compare_length(const char *a, const char *b, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + k, 8);
+        memcpy(&y, b + k, 8);
+        if (x != y) break;
+    }
+    for (; k < len; ++k) {
+        if (a[k] != b[k]) return k + 1;
+    }
+    return len;
+}
+
+// verify the candidate at s + i, false means it is a match
+inline bool mismatch(const char *s, size_t i, const char *p, size_t m, size_t &verified) {
+    size_t len = compare_length(s + i + 1, p + 1, m - 1);
+    verified += 1 + len;
+    return len < m - 1 || s[i + m - 1] != p[m - 1];
+}
+
+// allowed verification bytes when i positions have been scanned
+inline bool over_budget(size_t verified, size_t i) { return verified > i + 4096; }
+
+size_t prefilter_scalar(const char *s, size_t n, const char *p, size_t m, size_t *resume) {
+    size_t res = 0, verified = 0, last = n - m;
+    for (size_t i = 0; i <= last; ++i) {
+        const void *hit = memchr(s + i, p[0], last + 1 - i);
+        if (!hit) break;
+        i = static_cast<const char *>(hit) - s;
+        if (s[i + m - 1] != p[m - 1]) continue;
+        if (!mismatch(s, i, p, m, verified)) ++res;
+        if (over_budget(verified, i)) {
+            *resume = i + 1;
+            return res;
+        }
+    }
+    *resume = last + 1;
+    return res;
+}
+
+#ifdef KMP_SIMD_X86
+// mask has one bit per candidate position starting at s + i
+inline bool verify_mask(uint32_t mask, const char *s, size_t i, const char *p, size_t m,
+                        size_t &res, size_t &verified) {
+    for (; mask; mask &= mask - 1) {
+        if (!mismatch(s, i + __builtin_ctz(mask), p, m, verified)) ++res;
+    }
+    return over_budget(verified, i);
+}
+
+size_t prefilter_sse2(const char *s, size_t n, const char *p, size_t m, size_t *resume) {
+    const __m128i first = _mm_set1_epi8(p[0]), last = _mm_set1_epi8(p[m - 1]);
+    size_t res = 0, verified = 0, i = 0;
+    for (; i + 16 + m - 1 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + m - 1));
+        uint32_t mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        if (mask && verify_mask(mask, s, i, p, m, res, verified)) {
+            i += 16;
+            break;
+        }
+    }
+    *resume = i;
+    return res;
+}
+
+__attribute__((target("avx2"))) size_t prefilter_avx2(const char *s, size_t n, const char *p,
+                                                      size_t m, size_t *resume) {
+    const __m256i first = _mm256_set1_epi8(p[0]), last = _mm256_set1_epi8(p[m - 1]);
+    size_t res = 0, verified = 0, i = 0;
+    for (; i + 32 + m - 1 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i + m - 1));
+        uint32_t mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        if (mask && verify_mask(mask, s, i, p, m, res, verified)) {
+            i += 32;
+            break;
+        }
+    }
+    *resume = i;
+    return res;
+}
+#endif
+
+// widest kernel the running cpu supports
+inline prefilter_fn best_prefilter() {
+#ifdef KMP_SIMD_X86
+    static const prefilter_fn fn =
+        __builtin_cpu_supports("avx2") ? prefilter_avx2 : prefilter_sse2;
+    return fn;
+#else
+    return prefilter_scalar;
+#endif
+}
+
+}  // namespace kmp_impl
+
+// Same count as kmp(), overlapping matches included, but candidate positions
+// are found by the prefilter kernel, kernel defaults to the widest available.
+// The positions the kernel leaves over are finished by KMP.
+size_t kmp_simd(const string &str, const string &pattern,
+                kmp_impl::prefilter_fn kernel = kmp_impl::best_prefilter()) {
+    size_t n = str.size(), m = pattern.size();
+    if (m == 0) return n;
+    if (m > n) return 0;
+
+    size_t resume = 0;
+    size_t res = kernel(str.data(), n, pattern.data(), m, &resume);
+    if (resume + m <= n) {
+        KmpMatcher matcher(pattern);
+        matcher.feed(string_view(str).substr(resume), [&res](size_t) { ++res; });
+    }
+    return res;
+}
+
+// Aho-Corasick automaton, the failure function of make_next generalized from
+// one pattern to a trie of many. Built once and reused, it finds every
+// occurrence of every pattern in a single pass over the text.
+//
+// Shallow states are hit on almost every byte, so they keep a dense row of
+// 256 resolved transitions. Deeper states only keep their sorted trie edges
+// and fall back along the failure links, which always end in a dense state.
+class AhoCorasick {
+public:
+    AhoCorasick(const vector<string> &patterns) : lens(patterns.size()) {
+        vector<vector<pair<unsigned char, int>>> children(1);
+        vector<vector<int>> own(1);
+        vector<int> depth(1, 0);
+        for (int id = 0; id < int(patterns.size()); ++id) {
+            assert(!patterns[id].empty());
+            lens[id] = patterns[id].size();
+            int s = 0;
+            for (unsigned char c : patterns[id]) {
+                auto it = find_if(children[s].begin(), children[s].end(),
+                                  [c](const pair<unsigned char, int> &e) { return e.first == c; });
+                if (it != children[s].end()) {
+                    s = it->second;
+                    continue;
+                }
+                children[s].emplace_back(c, int(children.size()));
+                children.emplace_back();
+                own.emplace_back();
+                depth.push_back(depth[s] + 1);
+                s = children.size() - 1;
+            }
+            own[s].push_back(id);
+        }
+
+        states.resize(children.size());
+        for (int s = 0; s < int(children.size()); ++s) {
+            sort(children[s].begin(), children[s].end());
+            states[s].edge_begin = edge_chars.size();
+            for (auto &e : children[s]) {
+                edge_chars.push_back(e.first);
+                edge_next.push_back(e.second);
+            }
+            states[s].edge_end = edge_chars.size();
+            states[s].out_begin = out_ids.size();
+            out_ids.insert(out_ids.end(), own[s].begin(), own[s].end());
+            states[s].out_end = out_ids.size();
+        }
+
+        // breadth first, so the failure target of a state is always complete
+        queue<int> bfs;
+        bfs.push(0);
+        while (!bfs.empty()) {
+            int s = bfs.front();
+            bfs.pop();
+            State &st = states[s];
+            if (depth[s] <= DENSE_DEPTH && int(dense.size()) < MAX_DENSE_STATES * 256) {
+                st.dense = dense.size() / 256;
+                dense.resize(dense.size() + 256, 0);
+                for (int c = 0; c < 256; ++c) {
+                    dense[st.dense * 256 + c] = s == 0 ? 0 : step(st.fail, c);
+                }
+                for (auto &e : children[s]) dense[st.dense * 256 + e.first] = e.second;
+            }
+            for (auto &e : children[s]) {
+                State &child = states[e.second];
+                child.fail = s == 0 ? 0 : step(st.fail, e.first);
+                const State &f = states[child.fail];
+                child.dict = f.out_begin != f.out_end ? child.fail : f.dict;
+                child.reports = child.out_begin != child.out_end || child.dict >= 0;
+                bfs.push(e.second);
+            }
+        }
+    }
+
+    // Call on_match(pattern id, offset of the match) for every occurrence,
+    // ordered by the end of the match.
+    template <class F>
+    void scan(const char *text, size_t n, F on_match) const {
+        int s = 0;
+        for (size_t i = 0; i < n; ++i) {
+            s = step(s, text[i]);
+            if (!states[s].reports) continue;
+            for (int t = s; t >= 0; t = states[t].dict) {
+                const State &st = states[t];
+                for (int k = st.out_begin; k < st.out_end; ++k) {
+                    on_match(out_ids[k], i + 1 - lens[out_ids[k]]);
+                }
+            }
+        }
+    }
+
+    template <class F>
+    void scan(const string &text, F on_match) const {
+        scan(text.data(), text.size(), on_match);
+    }
+
+    size_t count(const string &text) const {
+        size_t res = 0;
+        scan(text, [&res](int, size_t) { ++res; });
+        return res;
+    }
+
+private:
+    // states up to this depth get a dense row, at most MAX_DENSE_STATES of them
+    static constexpr int DENSE_DEPTH = 2;
+    static constexpr int MAX_DENSE_STATES = 1 << 12;
+
+    struct State {
+        int fail = 0;
+        int dict = -1;  // nearest state on the failure chain that ends a pattern
+        int dense = -1;
+        int edge_begin = 0, edge_end = 0;
+        int out_begin = 0, out_end = 0;
+        bool reports = false;  // some pattern ends here or on the failure chain
+    };
+
+    vector<State> states;
+    vector<int> dense;
+    vector<unsigned char> edge_chars;
+    vector<int> edge_next;
+    vector<int> out_ids;
+    vector<size_t> lens;
+
+    int step(int s, unsigned char c) const {
+        while (true) {
+            const State &st = states[s];
+            if (st.dense >= 0) return dense[st.dense * 256 + c];
+            for (int k = st.edge_begin; k < st.edge_end; ++k) {
+                if (edge_chars[k] == c) return edge_next[k];
+            }
+            s = st.fail;
+        }
+    }
+};
+
+// Benchmark, run with `bench [max_n]`. The text is drawn from a 4 letter
+// alphabet so that the failure links are actually followed.
+void benchmark(size_t max_n) {
+    default_random_engine eng(42);
+    string pattern = "abcabdab";
+    for (size_t n : bench::sizes(max_n)) {
+        string text(n, 'a');
+        for (auto& c : text) c = 'a' + eng() % 4;
+
+        long sink = 0;
+        bench::Record rec("kmp", "kmp", n);
+        rec.set("m", pattern.size());
+        double ops_per_s = bench::measure_ops(rec, 3, [&](size_t) { sink += kmp(text, pattern); });
+        rec.set("bytes_per_s", ops_per_s * n);
+        rec.print();
+
+        bench::Record simd("kmp", "simd", n);
+        simd.set("m", pattern.size());
+        ops_per_s = bench::measure_ops(simd, 3, [&](size_t) { sink += kmp_simd(text, pattern); });
+        simd.set("bytes_per_s", ops_per_s * n);
+        simd.print();
+
+        KmpMatcher matcher(pattern);
+        bench::Record stream("kmp", "stream", n);
+        stream.set("m", pattern.size()).set("chunk", 1 << 16);
+        ops_per_s = bench::measure_ops(stream, 3, [&](size_t) {
+            matcher.reset();
+            for (size_t i = 0; i < n; i += 1 << 16) {
+                matcher.feed(string_view(text).substr(i, 1 << 16), [&sink](size_t) { ++sink; });
+            }
+        });
+        stream.set("bytes_per_s", ops_per_s * n);
+        bench::do_not_optimize(sink);
+        stream.print();
+    }
+
+    // chunked search scaling, until memory bandwidth runs out
+    int max_threads = max(1u, thread::hardware_concurrency());
+    for (size_t n : bench::sizes(max_n)) {
+        string text(n, 'a');
+        for (auto &c : text) c = 'a' + eng() % 4;
+
+        for (int threads = 1;; threads = min(threads * 2, max_threads)) {
+            size_t sink = 0;
+            ParallelKmp pk(pattern, threads);
+            bench::Record rec("kmp", "parallel", n);
+            rec.set("m", pattern.size()).set("threads", threads);
+            double ops_per_s = bench::measure_ops(rec, 3, [&](size_t) { sink += pk.count(text); });
+            rec.set("bytes_per_s", ops_per_s * n);
+            bench::do_not_optimize(sink);
+            rec.print();
+            if (threads == max_threads) break;
+        }
+    }
+
+    // Aho-Corasick against one kmp() pass per pattern, over a 26 letter text
+    uniform_int_distribution<int> len_dist(6, 12);
+    for (size_t n : bench::sizes(max_n)) {
+        string text(n, 'a');
+        for (auto &c : text) c = 'a' + eng() % 26;
+
+        for (size_t k : {16, 256, 4096}) {
+            vector<string> patterns(k);
+            for (auto &p : patterns) {
+                p.resize(len_dist(eng));
+                for (auto &c : p) c = 'a' + eng() % 26;
+            }
+
+            size_t sink = 0;
+            unique_ptr<AhoCorasick> ac;
+            bench::Record rec("AhoCorasick", "scan", n);
+            rec.set("patterns", k);
+            bench::measure_build(rec, [&] { ac.reset(new AhoCorasick(patterns)); });
+            double ops_per_s = bench::measure_ops(rec, 3, [&](size_t) { sink += ac->count(text); });
+            rec.set("gb_per_s", ops_per_s * n / 1e9);
+            rec.print();
+
+            // the looped baseline gets slow quickly, keep it to small products
+            if (n * k > 100000000) continue;
+            bench::Record loop("AhoCorasick", "kmp_loop", n);
+            loop.set("patterns", k);
+            ops_per_s = bench::measure_ops(loop, 1, [&](size_t) {
+                for (auto &p : patterns) sink += kmp(text, p);
+            });
+            loop.set("gb_per_s", ops_per_s * n / 1e9);
+            loop.print();
+            bench::do_not_optimize(sink);
+        }
+    }
+}
+
+void random_test() {
+    random_device r;
+    default_random_engine eng(r());
+    uniform_int_distribution<int> len_dist(1, 6);
+
+    string text(10000, 'a');
+    for (auto &c : text) c = 'a' + eng() % 3;
+    vector<string> patterns(50);
+    for (auto &p : patterns) {
+        p.resize(len_dist(eng));
+        for (auto &c : p) c = 'a' + eng() % 3;
+    }
+
+    cout << "Begin random test on " << patterns.size() << " patterns!" << endl;
+    AhoCorasick ac(patterns);
+    vector<pair<int, size_t>> hits, expected;
+    ac.scan(text, [&hits](int id, size_t offset) { hits.emplace_back(id, offset); });
+    sort(hits.begin(), hits.end());
+    for (int id = 0; id < int(patterns.size()); ++id) {
+        for (size_t i = 0; i + patterns[id].size() <= text.size(); ++i) {
+            if (text.compare(i, patterns[id].size(), patterns[id]) == 0) expected.emplace_back(id, i);
+        }
+    }
+    vector<int> counts(patterns.size()), kmp_counts(patterns.size());
+    for (auto &h : hits) ++counts[h.first];
+    for (size_t i = 0; i < patterns.size(); ++i) kmp_counts[i] = kmp(text, patterns[i]);
+    assert(hits == expected);
+    assert(counts == kmp_counts);
+    cout << "Test passed!" << endl;
+}
+
+void stream_test() {
+    random_device r;
+    default_random_engine eng(r());
+
+    string text(100000, 'a'), pattern = "abab";
+    for (auto &c : text) c = 'a' + eng() % 2;
+
+    vector<size_t> expected;
+    for (size_t i = 0; i + pattern.size() <= text.size(); ++i) {
+        if (text.compare(i, pattern.size(), pattern) == 0) expected.push_back(i);
+    }
+
+    cout << "Begin stream test on " << expected.size() << " matches!" << endl;
+    // chunks of random size, so matches straddle the boundaries
+    KmpMatcher matcher(pattern);
+    vector<size_t> offsets;
+    for (size_t i = 0; i < text.size();) {
+        size_t len = min<size_t>(text.size() - i, eng() % 7);
+        matcher.feed(string_view(text).substr(i, len), [&](size_t o) { offsets.push_back(o); });
+        i += len;
+    }
+    assert(offsets == expected);
+    assert(int(offsets.size()) == kmp(text, pattern));
+
+    string path = "kmp_stream.txt";
+    FILE *file = fopen(path.c_str(), "wb");
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    offsets.clear();
+    size_t cnt = kmp_file(path, pattern, [&](size_t o) { offsets.push_back(o); }, 1000);
+    remove(path.c_str());
+    assert(cnt == expected.size() && offsets == expected);
+    (void)cnt;
+    cout << "Test passed!" << endl;
+}
+
+void simd_test() {
+    random_device r;
+    default_random_engine eng(r());
+
+    vector<kmp_impl::prefilter_fn> kernels = {kmp_impl::prefilter_scalar};
+#ifdef KMP_SIMD_X86
+    kernels.push_back(kmp_impl::prefilter_sse2);
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(kmp_impl::prefilter_avx2);
+#endif
+
+    cout << "Begin simd test on " << kernels.size() << " kernels!" << endl;
+    for (int alphabet : {1, 2, 26}) {
+        for (int t = 0; t < 200; ++t) {
+            string text(eng() % 3000, 'a'), pattern(1 + eng() % 40, 'a');
+            for (auto &c : text) c = 'a' + eng() % alphabet;
+            for (auto &c : pattern) c = 'a' + eng() % alphabet;
+            size_t expected = kmp(text, pattern);
+            for (auto kernel : kernels) {
+                size_t got = kmp_simd(text, pattern, kernel);
+                assert(got == expected);
+                (void)got;
+            }
+            (void)expected;
+        }
+    }
+
+    // a candidate every 8 bytes, each verified over almost the whole pattern
+    string period = "abcdefgh", text, pattern;
+    while (text.size() < (1 << 20)) text += period;
+    while (pattern.size() < 2000) pattern += period;
+    pattern += "Xb";
+    for (auto kernel : kernels) {
+        size_t resume = 0;
+        kernel(text.data(), text.size(), pattern.data(), pattern.size(), &resume);
+        size_t got = kmp_simd(text, pattern, kernel);
+        assert(resume < text.size() / 16);  // handed over to KMP early
+        assert(got == 0);
+        (void)resume;
+        (void)got;
+    }
+    cout << "Test passed!" << endl;
+}
+
+void parallel_test() {
+    random_device r;
+    default_random_engine eng(r());
+
+    string text(1 << 20, 'a');
+    for (auto &c : text) c = 'a' + eng() % 2;
+
+    cout << "Begin parallel test!" << endl;
+    for (string pattern : {"a", "abab", "aaaaaaaaaa", "abbabaabba"}) {
+        vector<size_t> expected;
+        KmpMatcher(pattern).feed(text, [&](size_t o) { expected.push_back(o); });
+        for (int threads : {1, 3, 8}) {
+            ParallelKmp pk(pattern, threads);
+            size_t cnt = pk.count(text);
+            vector<size_t> offsets = pk.offsets(text);
+            assert(cnt == expected.size());
+            assert(offsets == expected);
+            (void)cnt;
+        }
+    }
+    cout << "Test passed!" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmark(bench::max_size(argc, argv, 100000000));
+        return 0;
+    }
+
+    cout << kmp("abababa", "aba") << endl;  // 3
+    cout << kmp("aaaaa", "aa") << endl;     // 4
+    cout << kmp("abcde", "f") << endl;      // 0
+    assert(kmp("abababa", "aba") == 3 && kmp("aaaaa", "aa") == 4 && kmp("abcde", "f") == 0);
+
+    AhoCorasick ac({"he", "she", "his", "hers"});
+    vector<pair<int, size_t>> hits;
+    ac.scan("ushers", [&hits](int id, size_t offset) { hits.emplace_back(id, offset); });
+    // she at 1, he at 2, hers at 2
+    assert((hits == vector<pair<int, size_t>>{{1, 1}, {0, 2}, {3, 2}}));
+
+    random_test();
+    stream_test();
+    simd_test();
+    parallel_test();
+
+    return 0;
+}
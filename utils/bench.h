@@ -0,0 +1,243 @@
+#ifndef __BENCH_HEADER__
+#define __BENCH_HEADER__
+
+// Tiny benchmark helpers shared by the snippets. Every measurement is printed
+// as one JSON object per line, so runs can be diffed to catch regressions.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BENCH_MALLINFO2
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+template <class F>
+double time_ms(F f) {
+    uint64_t start = now_ns();
+    f();
+    return (now_ns() - start) / 1e6;
+}
+
+// keep a computed value alive without the compiler dropping the computation
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// resident set size of the process, 0 if unknown
+inline size_t rss_bytes() {
+#ifdef __linux__
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return size_t(resident) * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+// bytes currently handed out by malloc, including mmapped chunks; falls back
+// to the resident set size where glibc's mallinfo2 is not available
+inline size_t allocated_bytes() {
+#ifdef BENCH_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return rss_bytes();
+#endif
+}
+
+// sizes 10^3, 10^4, ... up to max_n
+inline std::vector<size_t> sizes(size_t max_n) {
+    std::vector<size_t> res;
+    for (size_t n = 1000; n <= max_n; n *= 10) res.push_back(n);
+    return res;
+}
+
+// `prog bench [max_n]`, max_n defaults to def
+inline size_t max_size(int argc, char* argv[], size_t def) {
+    return argc > 2 ? std::strtoull(argv[2], nullptr, 10) : def;
+}
+
+// One JSON object, fields are printed in insertion order.
+class Record {
+private:
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    static std::string quote(const std::string& s) {
+        std::string res = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') res += '\\';
+            res += c;
+        }
+        return res + "\"";
+    }
+
+public:
+    Record(const std::string& structure, const std::string& op, size_t n) {
+        set("structure", structure);
+        set("op", op);
+        set("n", n);
+    }
+
+    Record& set(const std::string& key, const std::string& value) {
+        fields.emplace_back(key, quote(value));
+        return *this;
+    }
+
+    Record& set(const std::string& key, const char* value) { return set(key, std::string(value)); }
+
+    template <class T>
+    Record& set(const std::string& key, T value) {
+        std::ostringstream os;
+        os << value;
+        fields.emplace_back(key, os.str());
+        return *this;
+    }
+
+    void print(std::ostream& os = std::cout) const {
+        os << "{";
+        for (size_t i = 0; i < fields.size(); ++i) {
+            os << (i ? ", " : "") << quote(fields[i].first) << ": " << fields[i].second;
+        }
+        os << "}" << std::endl;
+    }
+};
+
+// Hardware counters through perf_event_open. Counters the kernel refuses are
+// skipped silently, so the benchmarks still run in containers.
+class PerfCounters {
+private:
+    std::vector<std::pair<const char*, int>> fds;
+
+public:
+    PerfCounters() {
+#ifdef __linux__
+        if (!std::getenv("BENCH_PERF")) return;
+        const std::pair<const char*, uint64_t> events[] = {
+            {"cycles", PERF_COUNT_HW_CPU_CYCLES},
+            {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+            {"cache_misses", PERF_COUNT_HW_CACHE_MISSES},
+            {"branch_misses", PERF_COUNT_HW_BRANCH_MISSES},
+        };
+        for (auto& e : events) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = e.second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            int fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd >= 0) fds.emplace_back(e.first, fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (auto& it : fds) close(it.second);
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+        for (auto& it : fds) {
+            ioctl(it.second, PERF_EVENT_IOC_RESET, 0);
+            ioctl(it.second, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // stop counting and store counts per op into rec
+    void stop(Record& rec, size_t ops) {
+#ifdef __linux__
+        for (auto& it : fds) {
+            ioctl(it.second, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count = 0;
+            if (read(it.second, &count, sizeof(count)) == sizeof(count)) {
+                rec.set(std::string(it.first) + "_per_op", double(count) / std::max<size_t>(ops, 1));
+            }
+        }
+#else
+        (void)rec;
+        (void)ops;
+#endif
+    }
+};
+
+// Time the construction in f() and the heap it leaves allocated. The resident
+// set is no good here, it stays flat when malloc reuses freed pages.
+template <class F>
+void measure_build(Record& rec, F f) {
+    size_t before = allocated_bytes();
+    rec.set("build_ms", time_ms(f));
+    size_t after = allocated_bytes();
+    rec.set("memory_bytes", after > before ? after - before : 0);
+}
+
+// Run f(i) for i in [0, ops). Throughput and hardware counters come from one
+// untimed loop, latency percentiles from individually timed calls on up to
+// 1 << 16 more of them. Returns the throughput in ops per second.
+template <class F>
+double measure_ops(Record& rec, size_t ops, F f) {
+    PerfCounters counters;
+    counters.start();
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < ops; ++i) f(i);
+    uint64_t total = now_ns() - start;
+    counters.stop(rec, ops);
+
+    std::vector<uint64_t> lat(std::min<size_t>(ops, 1 << 16));
+    for (size_t i = 0; i < lat.size(); ++i) {
+        uint64_t t = now_ns();
+        f(i);
+        lat[i] = now_ns() - t;
+    }
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) { return lat.empty() ? 0 : lat[size_t(p * (lat.size() - 1))]; };
+
+    double ops_per_s = ops / (std::max<uint64_t>(total, 1) / 1e9);
+    rec.set("ops", ops)
+        .set("ops_per_s", ops_per_s)
+        .set("p50_ns", pct(0.5))
+        .set("p90_ns", pct(0.9))
+        .set("p99_ns", pct(0.99))
+        .set("max_ns", lat.empty() ? 0 : lat.back());
+    return ops_per_s;
+}
+
+}  // namespace bench
+
+#endif /* ifndef __BENCH_HEADER__ */
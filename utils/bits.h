@@ -0,0 +1,112 @@
+#ifndef __BITS_HEADER__
+#define __BITS_HEADER__
+
+// Bit scan helpers, the C++ successor of fls.c. fls and floor_log2 are
+// constexpr, so they also size templates at compile time. With GCC and Clang
+// they compile to bsr, or to lzcnt when the target has it. floor_log2_batch
+// handles whole arrays and picks AVX2 at run time when the cpu has it.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITS_X86
+#endif
+
+namespace bits {
+
+// Find last set: index of the highest set bit counted from 1, 0 for 0.
+template <class T>
+constexpr int fls(T x) {
+    static_assert(std::is_integral<T>::value, "fls needs an integer");
+    typedef typename std::make_unsigned<T>::type U;
+    U v = U(x);
+#if defined(__GNUC__) || defined(__clang__)
+    if (v == 0) return 0;
+    if (sizeof(U) <= sizeof(unsigned)) {
+        return int(sizeof(unsigned) * 8) - __builtin_clz(unsigned(v));
+    } else if (sizeof(U) <= sizeof(unsigned long)) {
+        return int(sizeof(unsigned long) * 8) - __builtin_clzl((unsigned long)(v));
+    } else {
+        return int(sizeof(unsigned long long) * 8) - __builtin_clzll((unsigned long long)(v));
+    }
+#else
+    int r = 0;
+    for (int s = sizeof(U) * 4; s; s >>= 1) {
+        if (v >> s) {
+            v >>= s;
+            r += s;
+        }
+    }
+    return r + (v != 0);
+#endif
+}
+
+// floor(log2(x)), -1 for 0
+template <class T>
+constexpr int floor_log2(T x) {
+    return fls(x) - 1;
+}
+
+// ceil(log2(x)) for x >= 1
+template <class T>
+constexpr int ceil_log2(T x) {
+    return x <= 1 ? 0 : fls(T(x - 1));
+}
+
+static_assert(fls(0u) == 0 && fls(1u) == 1 && fls(0x80000000u) == 32, "fls");
+static_assert(floor_log2(1000) == 9 && ceil_log2(1000) == 10, "log2");
+
+namespace impl {
+
+inline void floor_log2_scalar(const uint32_t* x, int32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = floor_log2(x[i]);
+}
+
+#ifdef BITS_X86
+// binary search on the highest bit, eight lanes at a time
+__attribute__((target("avx2"))) inline void floor_log2_avx2(const uint32_t* x, int32_t* out,
+                                                            size_t n) {
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i r = _mm256_set1_epi32(-1);
+        // nonzero lanes count 1 for the lowest bit, zero lanes stay at -1
+        r = _mm256_add_epi32(r, _mm256_andnot_si256(_mm256_cmpeq_epi32(v, zero), one));
+#define BITS_STEP(s)                                                                \
+    {                                                                               \
+        __m256i shifted = _mm256_srli_epi32(v, s);                                  \
+        __m256i high = _mm256_andnot_si256(_mm256_cmpeq_epi32(shifted, zero),       \
+                                           _mm256_set1_epi32(-1));                  \
+        v = _mm256_blendv_epi8(v, shifted, high);                                   \
+        r = _mm256_add_epi32(r, _mm256_and_si256(high, _mm256_set1_epi32(s)));      \
+    }
+        BITS_STEP(16) BITS_STEP(8) BITS_STEP(4) BITS_STEP(2) BITS_STEP(1)
+#undef BITS_STEP
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+    }
+    floor_log2_scalar(x + i, out + i, n - i);
+}
+#endif
+
+}  // namespace impl
+
+// out[i] = floor_log2(x[i]) for the whole array, e.g. the lengths
+// r - l + 1 of a batch of range queries.
+inline void floor_log2_batch(const uint32_t* x, int32_t* out, size_t n) {
+#if defined(BITS_X86) && defined(__AVX2__)
+    impl::floor_log2_avx2(x, out, n);
+#elif defined(BITS_X86)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    avx2 ? impl::floor_log2_avx2(x, out, n) : impl::floor_log2_scalar(x, out, n);
+#else
+    impl::floor_log2_scalar(x, out, n);
+#endif
+}
+
+}  // namespace bits
+
+#endif /* ifndef __BITS_HEADER__ */
@@ -0,0 +1,95 @@
+#ifndef __CDQ_HEADER__
+#define __CDQ_HEADER__
+
+// Offline CDQ divide and conquer. Events are given in time order; every
+// update contributes to the queries that come later in time and have a key
+// no smaller than its own, so it also reaches later queries with an equal key.
+//
+//   Event  needs is_update() and is_query().
+//   KeyOf  maps an event to its key, compared with <.
+//   Inner  handles the remaining dimension: insert(const Event&) and
+//          erase(const Event&) for updates, answer(Event&) for queries.
+//          A query keeps its own partial result, so two halves never write
+//          to the same place.
+//
+// Each level merges the two key-sorted halves instead of sorting again, so
+// the whole run costs O(n log n) inner operations. Insertions are undone
+// one by one after the sweep, so each worker reuses one Inner. The two halves
+// of a large range run as tasks on a work-stealing pool. Every worker keeps
+// its own Inner and merge buffer, so run() never starts more workers than
+// there are ranges of PARALLEL_CUTOFF events to fork.
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "task_pool.h"
+
+template <class Event, class KeyOf, class Inner>
+class Cdq {
+public:
+    Cdq(KeyOf key_of, const Inner& prototype, int threads = 0)
+        : key_of(key_of), prototype(prototype), threads(threads) {}
+
+    // Run over events, which end up sorted by key, each query carrying its result.
+    void run(std::vector<Event>& events) {
+        size_t cap = std::max<size_t>(1, events.size() / PARALLEL_CUTOFF);
+        int workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        TaskPool pool(int(std::min<size_t>(workers, cap)));
+        this->pool = &pool;
+        this->events = events.data();
+        inners.assign(pool.size(), prototype);
+        scratch.assign(pool.size(), std::vector<Event>());
+        solve(0, events.size());
+        this->pool = nullptr;
+    }
+
+private:
+    // ranges shorter than this recurse without forking
+    static constexpr size_t PARALLEL_CUTOFF = 1 << 12;
+
+    KeyOf key_of;
+    Inner prototype;
+    int threads;
+
+    TaskPool* pool = nullptr;
+    Event* events = nullptr;
+    std::vector<Inner> inners;
+    std::vector<std::vector<Event>> scratch;
+
+    void solve(size_t l, size_t r) {
+        if (r - l <= 1) return;
+        size_t m = (l + r) / 2;
+        if (r - l > PARALLEL_CUTOFF) {
+            pool->invoke([=] { solve(l, m); }, [=] { solve(m, r); });
+        } else {
+            solve(l, m);
+            solve(m, r);
+        }
+
+        int w = TaskPool::worker_id();
+        Inner& inner = inners[w];
+        std::vector<Event>& merged = scratch[w];
+        merged.clear();
+
+        // sweep both sorted halves by key, left updates feed right queries
+        size_t i = l, j = m;
+        while (j < r) {
+            if (i < m && !(key_of(events[j]) < key_of(events[i]))) {
+                if (events[i].is_update()) inner.insert(events[i]);
+                merged.push_back(events[i++]);
+            } else {
+                if (events[j].is_query()) inner.answer(events[j]);
+                merged.push_back(events[j++]);
+            }
+        }
+        // only [l, i) was inserted, the rest of the left half has nobody to feed
+        for (size_t k = l; k < i; ++k) {
+            if (events[k].is_update()) inner.erase(events[k]);
+        }
+        merged.insert(merged.end(), events + i, events + m);
+        std::copy(merged.begin(), merged.end(), events + l);
+    }
+};
+
+#endif /* ifndef __CDQ_HEADER__ */
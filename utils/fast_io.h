@@ -0,0 +1,167 @@
+#ifndef __FAST_IO_HEADER__
+#define __FAST_IO_HEADER__
+
+// Bulk integer input and buffered output for the contest style programs.
+//
+// FastInput maps the whole input when it is a regular file and otherwise
+// slurps it with large read() calls, e.g. from a pipe. Integers are parsed
+// eight digits at a time with SWAR arithmetic. FastOutput appends to one
+// growable buffer and writes it out once.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class FastInput {
+public:
+    FastInput(int fd = 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(p);
+                size = st.st_size;
+                mapped = true;
+                return;
+            }
+        }
+        size_t block = size_t(1) << 20;
+        while (true) {
+            buffer.resize(size + block);
+            ssize_t got = ::read(fd, buffer.data() + size, block);
+            if (got <= 0) break;
+            size += got;
+        }
+        data = buffer.data();
+    }
+
+    FastInput(const FastInput&) = delete;
+    FastInput& operator=(const FastInput&) = delete;
+
+    ~FastInput() {
+        if (mapped) munmap(const_cast<char*>(data), size);
+    }
+
+    // Parse the next integer, skipping anything that is not a digit or '-'.
+    // Returns false at the end of the input.
+    template <class T>
+    bool read(T& x) {
+        while (pos < size && !is_digit(data[pos]) && data[pos] != '-') ++pos;
+        if (pos == size) return false;
+
+        bool negative = data[pos] == '-';
+        pos += negative;
+        uint64_t res = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        while (pos + 8 <= size) {
+            uint64_t chunk;
+            memcpy(&chunk, data + pos, 8);
+            if (!all_digits(chunk)) break;
+            res = res * 100000000 + parse_eight(chunk);
+            pos += 8;
+        }
+#endif
+        for (; pos < size && is_digit(data[pos]); ++pos) res = res * 10 + (data[pos] - '0');
+        x = negative ? T(0 - res) : T(res);
+        return true;
+    }
+
+    template <class T>
+    T next() {
+        T x = 0;
+        read(x);
+        return x;
+    }
+
+    size_t bytes() const { return size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0, pos = 0;
+    bool mapped = false;
+    std::vector<char> buffer;
+
+    static bool is_digit(char c) { return unsigned(c - '0') < 10; }
+
+    // every byte is in '0'..'9'
+    static bool all_digits(uint64_t v) {
+        return !(((v + 0x4646464646464646ULL) | (v - 0x3030303030303030ULL)) &
+                 0x8080808080808080ULL);
+    }
+
+    // eight ascii digits, first digit in the lowest byte
+    static uint32_t parse_eight(uint64_t v) {
+        v -= 0x3030303030303030ULL;
+        v = v * 10 + (v >> 8);
+        v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+             (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >>
+            32;
+        return uint32_t(v);
+    }
+};
+
+class FastOutput {
+public:
+    FastOutput(int fd = 1) : fd(fd) {}
+
+    FastOutput(const FastOutput&) = delete;
+    FastOutput& operator=(const FastOutput&) = delete;
+
+    ~FastOutput() { flush(); }
+
+    FastOutput& put(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    FastOutput& write(const std::string& s) {
+        buffer.insert(buffer.end(), s.begin(), s.end());
+        return *this;
+    }
+
+    FastOutput& write(const char* s) { return write(std::string(s)); }
+
+    template <class T, class = typename std::enable_if<std::is_integral<T>::value>::type>
+    FastOutput& write(T x) {
+        char digits[24];
+        int len = 0;
+        uint64_t v = uint64_t(x);
+        if (std::is_signed<T>::value && x < T(0)) {
+            buffer.push_back('-');
+            v = 0 - v;
+        }
+        do {
+            digits[len++] = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        while (len) buffer.push_back(digits[--len]);
+        return *this;
+    }
+
+    void flush() {
+        for (size_t done = 0; done < buffer.size();) {
+            ssize_t got = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (got <= 0) break;
+            done += got;
+        }
+        flushed += buffer.size();
+        buffer.clear();
+    }
+
+    // bytes written so far, flushed or still buffered
+    size_t size() const { return flushed + buffer.size(); }
+
+private:
+    int fd;
+    size_t flushed = 0;
+    std::vector<char> buffer;
+};
+
+#endif /* ifndef __FAST_IO_HEADER__ */
@@ -0,0 +1,120 @@
+#ifndef __TASK_POOL_HEADER__
+#define __TASK_POOL_HEADER__
+
+// Fork-join pool with work stealing. Every worker owns a deque: it pushes and
+// pops forked tasks at the back, idle workers steal from the front of the
+// others. The thread that constructs the pool is worker 0, so fork-join code
+// can run on it directly. invoke() must be called from the constructing
+// thread or from inside a task.
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool {
+public:
+    TaskPool(int threads = 0) {
+        if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < threads; ++i) workers.emplace_back(new Worker());
+        previous = current;
+        current = 0;
+        for (int i = 1; i < threads; ++i) {
+            pool.emplace_back([this, i] {
+                current = i;
+                while (!stop.load(std::memory_order_acquire)) {
+                    if (!run_one(i)) std::this_thread::yield();
+                }
+            });
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        stop.store(true, std::memory_order_release);
+        for (auto& th : pool) th.join();
+        current = previous;
+    }
+
+    int size() const { return workers.size(); }
+
+    // index of the calling worker, in [0, size())
+    static int worker_id() { return current; }
+
+    // Run a and b, possibly in parallel, and return once both have finished.
+    // b is offered to thieves while a runs on the calling worker.
+    template <class A, class B>
+    void invoke(A&& a, B&& b) {
+        int self = current;
+        Task task{std::function<void()>(std::forward<B>(b))};
+        push(self, &task);
+        a();
+        if (pop_if(self, &task)) {
+            task.fn();
+            return;
+        }
+        // stolen, help with other work until the thief is done
+        while (!task.done.load(std::memory_order_acquire)) {
+            if (!run_one(self)) std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::atomic<bool> done{false};
+    };
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> pool;
+    std::atomic<bool> stop{false};
+    int previous;
+
+    static inline thread_local int current = 0;
+
+    void push(int w, Task* task) {
+        std::lock_guard<std::mutex> guard(workers[w]->lock);
+        workers[w]->tasks.push_back(task);
+    }
+
+    // take task back if nobody stole it
+    bool pop_if(int w, Task* task) {
+        std::lock_guard<std::mutex> guard(workers[w]->lock);
+        auto& q = workers[w]->tasks;
+        if (q.empty() || q.back() != task) return false;
+        q.pop_back();
+        return true;
+    }
+
+    Task* take(int w, bool own) {
+        std::lock_guard<std::mutex> guard(workers[w]->lock);
+        auto& q = workers[w]->tasks;
+        if (q.empty()) return nullptr;
+        Task* task = own ? q.back() : q.front();
+        own ? q.pop_back() : q.pop_front();
+        return task;
+    }
+
+    // run one task from the own deque or a stolen one, false if there was none
+    bool run_one(int self) {
+        Task* task = take(self, true);
+        for (int i = 1; !task && i < size(); ++i) task = take((self + i) % size(), false);
+        if (!task) return false;
+        task->fn();
+        task->done.store(true, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif /* ifndef __TASK_POOL_HEADER__ */